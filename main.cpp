@@ -4,24 +4,68 @@
 #include <cstdio>
 #include <cctype>
 #include <cmath>
+#include <cstdint>
+#include <cstddef>
 #include <cassert>
 #include <iostream>
 #include <iomanip>
 #include <string>
 #include <vector>
 #include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+#include <mutex>
+#include <atomic>
 #include <algorithm>
 #include <functional>
 #include <memory>
+#include <new>
+#include <coroutine>
+#include <exception>
 #endif /* PROGTEST */
 
 class CIterator;
+class CChangeFeed;
+class CAsyncLookup;
 
 class CLandRegister
 {
 public:
-    CLandRegister(); // Default constructor
-    ~CLandRegister(); // Default destructor
+    enum class EChangeType { Add, Del, NewOwner };
+
+    struct CChange
+    {
+        EChangeType m_Type;
+        unsigned long long m_Sequence;
+        std::string m_City;
+        std::string m_Address;
+        std::string m_Region;
+        unsigned long long m_ID;
+        std::string m_Owner;
+    };
+
+    // Heap bytes by component, allocator headers are not included
+    struct CMemoryUsage
+    {
+        size_t m_Properties;
+        size_t m_Strings;
+        size_t m_CityAddrIndex;
+        size_t m_RegionIdIndex;
+        size_t m_OwnerIndex;
+        size_t m_Iterators;
+        size_t m_ChangeLog;
+        size_t m_OwnerCache;
+        size_t m_ColumnStore;
+
+        size_t total() const;
+    };
+
+    static const size_t DEFAULT_CHANGE_LOG_CAPACITY = 1024;
+
+    CLandRegister(); // Default constructor, change log is allocated on first subscribe()
+    explicit CLandRegister(size_t changeLogCapacity); // 0 disables the change feed
+    ~CLandRegister(); // Destructor, frees all properties
 
     bool add(const std::string& city, const std::string& addr,
              const std::string& region, unsigned long long id);
@@ -48,6 +92,38 @@ public:
 
     CIterator listByOwner(const std::string& owner) const;
 
+    // Convert into read-only columnar storage, add/del/newOwner fail afterwards;
+    // fails when already frozen, when the register holds 2^32 - 1 parcels or more,
+    // or while a CIterator listed from the live layout is still alive, since
+    // freezing frees the parcels such an iterator points to
+    bool freeze();
+    bool frozen() const;
+
+    // Footprint of the live layout before freeze() and of the columnar layout
+    bool freezeReport(size_t& liveBytes, size_t& frozenBytes) const;
+
+    // Enable a bounded LRU front cache for getOwner, capacity 0 disables it.
+    // Concurrent getOwner calls are safe, the cache is guarded by its own mutex;
+    // add/del/newOwner and this call still need exclusive access as before.
+    // A frozen register keeps the cache disabled, its lookups bypass it anyway.
+    void setOwnerCacheCapacity(size_t capacity);
+    size_t ownerCacheHits() const;
+    size_t ownerCacheMisses() const;
+
+    // Subscribe to add/del/newOwner events starting at the given sequence number,
+    // changes made before the first subscription are not recorded. Subscribing
+    // needs exclusive access, the returned feed may then poll from another thread
+    // while a single writer keeps modifying the register
+    CChangeFeed subscribe(unsigned long long fromSequence);
+
+    // Sequence number the next change will receive
+    unsigned long long nextSequence() const;
+
+    CMemoryUsage memoryUsage() const;
+
+    // Release capacity left behind by del and newOwner
+    void shrinkToFit();
+
     void printAll();
 
 private:
@@ -71,22 +147,154 @@ private:
 
         // Constructor
         m_Property(const std::string& city, const std::string& addr, const std::string& region, unsigned long long id);
-        m_Property(const std::string& city, const std::string address);
+        m_Property(const std::string& city, const std::string& address);
         m_Property(const std::string& region, unsigned long long id);
         ~m_Property();
     };
 
+    // Views into either the caller's strings or the cached property, so probing never allocates.
+    // City/address keys leave m_ID at 0, region/id keys leave m_Second empty.
+    struct m_CacheKey {
+
+        // Properties
+        std::string_view m_First;
+        std::string_view m_Second;
+        unsigned long long m_ID;
+
+        // Methods
+        bool operator == (const m_CacheKey& otherKey) const;
+        struct m_Hash {
+            size_t operator () (const m_CacheKey& key) const;
+        };
+    };
+
+    struct m_OwnerCache {
+
+        // Properties
+        size_t m_Capacity = 0;
+        bool m_ByRegion;
+        // Most recently used property is at the front, keys point into the property itself
+        std::list<m_Property*> m_Entries;
+        std::unordered_map<m_CacheKey, std::list<m_Property*>::iterator, m_CacheKey::m_Hash> m_Index;
+
+        // Methods
+        explicit m_OwnerCache(bool byRegion);
+        m_CacheKey keyOf(const m_Property* property) const;
+        m_Property* find(const m_CacheKey& key);
+        void insert(m_Property* property);
+        void erase(const m_Property* property);
+        void clear();
+        size_t memoryUsage() const;
+        void shrinkToFit();
+    };
+
+    struct m_ColumnStore {
+
+        static const size_t BLOCK_SIZE = 16;
+        static const size_t MAX_ROWS = UINT32_MAX;
+
+        // Dictionaries, sorted so codes order like the strings they encode
+        std::vector<std::string> m_Cities;
+        std::vector<std::string> m_Regions;
+        std::vector<std::string> m_Owners;
+
+        // Rows are in city/address order, the city column is run-length encoded as first row per city code
+        std::vector<uint32_t> m_CityStart;
+        std::vector<uint32_t> m_OwnerCode;
+        std::vector<uint32_t> m_IdPosition;
+        std::vector<uint32_t> m_RowsByAcquisition;
+
+        // Front-coded addresses, varint shared prefix, varint suffix length, suffix bytes;
+        // byte offsets are 64-bit, row numbers are capped at MAX_ROWS by freeze()
+        std::string m_AddrBytes;
+        std::vector<uint64_t> m_AddrBlocks;
+
+        // Region/id order, region column as first position per region code,
+        // ids as varint deltas, absolute at block and region starts
+        std::vector<uint32_t> m_RegionStart;
+        std::vector<uint32_t> m_RegionIdRows;
+        std::string m_IdBytes;
+        std::vector<uint64_t> m_IdBlocks;
+
+        // Methods
+        m_ColumnStore(const std::vector<m_Property*>& byCityAddr, const std::vector<m_Property*>& byRegionId);
+        size_t rows() const;
+        std::string city(size_t row) const;
+        std::string address(size_t row) const;
+        std::string region(size_t row) const;
+        unsigned long long id(size_t row) const;
+        const std::string& owner(size_t row) const;
+        unsigned long long idAt(size_t position) const;
+        bool findCityAddr(const std::string& city, const std::string& addr, size_t& row) const;
+        bool findRegionId(const std::string& region, unsigned long long id, size_t& row) const;
+        std::vector<bool> ownerMatches(const std::string& owner) const;
+        std::vector<uint32_t> rowsByOwner(const std::string& owner) const;
+        size_t countByOwner(const std::string& owner) const;
+        size_t memoryUsage() const;
+        static uint32_t CodeOf(const std::vector<std::string>& dictionary, const std::string& value);
+        static void PutVarint(std::string& bytes, unsigned long long value);
+        static unsigned long long GetVarint(const std::string& bytes, size_t& offset);
+    };
+
+    static size_t StringHeapBytes(const std::string& value);
+
+    void recordChange(EChangeType type, const m_Property* property);
+    void invalidateOwnerCache(const m_Property* property);
+    // Shared by getOwner and CAsyncLookup, a miss is counted only while the cache is enabled
+    bool findCachedOwner(m_OwnerCache& cache, const m_CacheKey& key, std::string& owner) const;
+    void cacheOwner(m_OwnerCache& cache, m_Property* property) const;
+
     friend class CIterator;
+    friend class CChangeFeed;
+    friend class CAsyncLookup;
     std::vector<m_Property*> sortedByCityAddr;
     std::vector<m_Property*> sortedByOwner;
     std::vector<m_Property*> sortedByRegionId;
     unsigned long long m_NextAcquisitionOrder = 0;
+
+    // Keys are compared exactly, so cached lookups keep the case-sensitive semantics
+    mutable std::mutex m_OwnerCacheMutex;
+    mutable m_OwnerCache m_CityAddrCache { false };
+    mutable m_OwnerCache m_RegionIdCache { true };
+    mutable size_t m_OwnerCacheHits = 0;
+    mutable size_t m_OwnerCacheMisses = 0;
+
+    // Slot is published by storing the payload first and the stamp (sequence + 1) last,
+    // a payload is never modified once stored so readers may copy it without a lock.
+    // The payload goes through std::atomic_load/atomic_store, std::atomic<shared_ptr>
+    // in libstdc++ 12 releases its internal lock with relaxed ordering after a load
+    struct m_ChangeSlot
+    {
+        std::atomic<unsigned long long> m_Stamp { 0 };
+        std::shared_ptr<const CChange> m_Change;
+    };
+
+    // Bounded ring of the most recent changes, slot = sequence % capacity,
+    // null while nobody subscribed so writers skip recording
+    size_t m_ChangeLogCapacity;
+    unsigned long long m_ChangeLogStart = 0;
+    std::unique_ptr<m_ChangeSlot[]> m_ChangeLog;
+    // Sequence the next change will receive, advanced after the slot is published
+    std::atomic<unsigned long long> m_ChangeHead { 0 };
+
+    // Set by freeze(), the sorted vectors are empty from then on
+    std::unique_ptr<m_ColumnStore> m_Frozen;
+    size_t m_LiveBytesBeforeFreeze = 0;
+
+    // Bytes held by the CIterator copies currently alive; shared so an iterator may
+    // outlive the register and atomic so const listings from several threads stay safe
+    std::shared_ptr<std::atomic<size_t>> m_IteratorBytes = std::make_shared<std::atomic<size_t>>(0);
+    // CIterator copies over the live layout currently alive, freeze() waits for none
+    std::shared_ptr<std::atomic<size_t>> m_LiveIterators = std::make_shared<std::atomic<size_t>>(0);
 };
 
 class CIterator
 {
 public:
     CIterator(const CLandRegister& landRegister, std::vector<CLandRegister::m_Property*> sortedProperties);
+    CIterator(const CLandRegister& landRegister, std::vector<uint32_t> frozenRows);
+    CIterator(const CLandRegister& landRegister, size_t beginRow, size_t endRow);
+    CIterator(const CIterator& other);
     ~CIterator();
 
     bool atEnd() const;
@@ -101,25 +309,205 @@ private:
     const CLandRegister &landRegister;
     size_t currentIndex;
     std::vector<CLandRegister::m_Property*> sortedProperties;
+    // Row numbers into the column store when the register is frozen,
+    // either listed explicitly or as the range [currentIndex, rangeEnd)
+    bool frozen;
+    bool rowRange;
+    size_t rangeEnd;
+    std::vector<uint32_t> frozenRows;
+    std::shared_ptr<std::atomic<size_t>> iteratorBytes;
+    // Null for frozen iterators, they hold no parcel pointers
+    std::shared_ptr<std::atomic<size_t>> liveIterators;
+
+    size_t footprint() const;
+    size_t row() const;
+};
+
+class CChangeFeed
+{
+public:
+    CChangeFeed(const CLandRegister& landRegister, unsigned long long nextSequence);
+    ~CChangeFeed();
+
+    // Fetch the next pending change, false when there is none or a resync is needed
+    bool poll(CLandRegister::CChange& change);
+    // True when the consumer fell behind and missed changes overwritten in the ring
+    bool needsResync() const;
+    // Skip to the current end of the feed, caller is expected to reload via listByAddr
+    void resync();
+    unsigned long long sequence() const;
+private:
+    const CLandRegister &landRegister;
+    unsigned long long nextSequence;
+};
+
+class CAsyncLookup
+{
+public:
+    // Fire-and-forget coroutine type for callers of the async lookups
+    struct CLookupTask
+    {
+        struct promise_type
+        {
+            CLookupTask get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    // Awaitable getOwner, resumes with the same result the synchronous getOwner returns,
+    // the keys are referenced and must outlive the co_await (temporaries in its full-expression do).
+    // Only CLookupTask coroutines may await it, the front end destroys them when abandoned
+    class COwnerLookup
+    {
+    public:
+        COwnerLookup(CAsyncLookup& front, const std::string& city, const std::string& addr, std::string& owner);
+        COwnerLookup(CAsyncLookup& front, const std::string& region, unsigned long long id, std::string& owner);
+
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<CLookupTask::promise_type> handle);
+        bool await_resume() const noexcept;
+    private:
+        friend class CAsyncLookup;
+        CAsyncLookup &front;
+        bool byRegion;
+        const std::string &city;
+        const std::string &addr;
+        const std::string &region;
+        unsigned long long id;
+        std::string &owner;
+        bool found;
+        std::coroutine_handle<> handle;
+    };
+
+    static const size_t DEFAULT_BATCH_SIZE = 64;
+
+    explicit CAsyncLookup(const CLandRegister& landRegister, size_t batchSize = DEFAULT_BATCH_SIZE);
+    // Pending lookups point back at their front end, a copy would resume or destroy them twice
+    CAsyncLookup(const CAsyncLookup&) = delete;
+    CAsyncLookup& operator = (const CAsyncLookup&) = delete;
+    // Coroutines still waiting on a lookup are destroyed without being resumed
+    ~CAsyncLookup();
+
+    COwnerLookup getOwner(const std::string& city, const std::string& addr, std::string& owner);
+    COwnerLookup getOwner(const std::string& region, unsigned long long id, std::string& owner);
+
+    // Resolve pending lookups batch by batch and resume their coroutines until none is left
+    size_t run();
+    size_t pending() const;
+private:
+    void resolveBatch(std::vector<COwnerLookup*>& batch);
+    void resolveCityAddr(std::vector<COwnerLookup*>& lookups);
+    void resolveRegionId(std::vector<COwnerLookup*>& lookups);
+    static void Prefetch(const void* address);
+    template <typename TLess>
+    static void LowerBoundBatch(const std::vector<CLandRegister::m_Property*>& properties,
+                                const std::vector<COwnerLookup*>& lookups, TLess less, std::vector<size_t>& positions);
+
+    const CLandRegister &landRegister;
+    size_t batchSize;
+    std::vector<COwnerLookup*> pendingLookups;
 };
 
-CLandRegister::CLandRegister() {}
+CLandRegister::CLandRegister() : m_ChangeLogCapacity(DEFAULT_CHANGE_LOG_CAPACITY) {}
+
+CLandRegister::CLandRegister(size_t changeLogCapacity) : m_ChangeLogCapacity(changeLogCapacity)
+{
+    if (m_ChangeLogCapacity) {
+        m_ChangeLog = std::make_unique<m_ChangeSlot[]>(m_ChangeLogCapacity);
+    }
+}
 
-CLandRegister::~CLandRegister() {}
+CLandRegister::~CLandRegister()
+{
+    for (m_Property* property : sortedByCityAddr) {
+        delete property;
+    }
+}
 
 CLandRegister::m_Property::m_Property(const std::string& city, const std::string& address, const std::string& region, unsigned long long id)
         : m_City(city), m_Address(address), m_Region(region), m_ID(id) {}
 
-CLandRegister::m_Property::m_Property(const std::string& city, const std::string address) : m_City(city), m_Address(address) {}
+CLandRegister::m_Property::m_Property(const std::string& city, const std::string& address) : m_City(city), m_Address(address) {}
 
 CLandRegister::m_Property::m_Property(const std::string &region, unsigned long long id) : m_Region(region), m_ID(id) {}
 
 CLandRegister::m_Property::~m_Property() {}
 
 CIterator::CIterator(const CLandRegister& landRegister, std::vector<CLandRegister::m_Property*> sortedProperties)
-        : landRegister(landRegister), currentIndex(0), sortedProperties(sortedProperties) {}
+        : landRegister(landRegister), currentIndex(0), sortedProperties(sortedProperties), frozen(false),
+          rowRange(false), rangeEnd(0), iteratorBytes(landRegister.m_IteratorBytes),
+          liveIterators(landRegister.m_LiveIterators)
+{
+    *iteratorBytes += footprint();
+    ++*liveIterators;
+}
+
+CIterator::CIterator(const CLandRegister& landRegister, std::vector<uint32_t> frozenRows)
+        : landRegister(landRegister), currentIndex(0), frozen(true), rowRange(false), rangeEnd(0),
+          frozenRows(std::move(frozenRows)),
+          iteratorBytes(landRegister.m_IteratorBytes)
+{
+    *iteratorBytes += footprint();
+}
+
+CIterator::CIterator(const CLandRegister& landRegister, size_t beginRow, size_t endRow)
+        : landRegister(landRegister), currentIndex(beginRow), frozen(true), rowRange(true), rangeEnd(endRow),
+          iteratorBytes(landRegister.m_IteratorBytes)
+{
+    *iteratorBytes += footprint();
+}
+
+CIterator::CIterator(const CIterator& other)
+        : landRegister(other.landRegister), currentIndex(other.currentIndex), sortedProperties(other.sortedProperties),
+          frozen(other.frozen), rowRange(other.rowRange), rangeEnd(other.rangeEnd), frozenRows(other.frozenRows),
+          iteratorBytes(other.iteratorBytes), liveIterators(other.liveIterators)
+{
+    *iteratorBytes += footprint();
+    if (liveIterators) {
+        ++*liveIterators;
+    }
+}
+
+CIterator::~CIterator()
+{
+    *iteratorBytes -= footprint();
+    if (liveIterators) {
+        --*liveIterators;
+    }
+}
+
+CChangeFeed::CChangeFeed(const CLandRegister& landRegister, unsigned long long nextSequence)
+        : landRegister(landRegister), nextSequence(nextSequence) {}
+
+CChangeFeed::~CChangeFeed() {}
+
+CAsyncLookup::CAsyncLookup(const CLandRegister& landRegister, size_t batchSize)
+        : landRegister(landRegister), batchSize(batchSize ? batchSize : 1) {}
 
-CIterator::~CIterator() {}
+CAsyncLookup::~CAsyncLookup()
+{
+    // Lookup objects live in the frames being destroyed, take the handles out first
+    std::vector<std::coroutine_handle<>> handles;
+    for (const COwnerLookup* lookup : pendingLookups) {
+        handles.push_back(lookup->handle);
+    }
+    pendingLookups.clear();
+
+    for (std::coroutine_handle<> handle : handles) {
+        handle.destroy();
+    }
+}
+
+CAsyncLookup::COwnerLookup::COwnerLookup(CAsyncLookup& front, const std::string& city, const std::string& addr,
+                                         std::string& owner)
+        : front(front), byRegion(false), city(city), addr(addr), region(city), id(0), owner(owner), found(false) {}
+
+CAsyncLookup::COwnerLookup::COwnerLookup(CAsyncLookup& front, const std::string& region, unsigned long long id,
+                                         std::string& owner)
+        : front(front), byRegion(true), city(region), addr(region), region(region), id(id), owner(owner), found(false) {}
 
 bool CLandRegister::m_Property::operator < (const m_Property& otherProperty) const
 {
@@ -148,7 +536,7 @@ bool CLandRegister::m_Property::CompareIDLessThan(const CLandRegister::m_Propert
 }
 
 bool CLandRegister::add(const std::string& city, const std::string& address, const std::string& region, unsigned long long id) {
-    if(city.empty() || address.empty() || region.empty()) {
+    if(m_Frozen || city.empty() || address.empty() || region.empty()) {
         return false;
     }
     std::string locCity(city);
@@ -193,13 +581,14 @@ bool CLandRegister::add(const std::string& city, const std::string& address, con
     sortedByCityAddr.insert(listCityAddressIt, newProperty);
     sortedByRegionId.insert(listRegionIdIt, newProperty);
     newProperty->m_AcquisitionTimestamp = m_NextAcquisitionOrder++;
+    recordChange(EChangeType::Add, newProperty);
 
     return true;
 }
 
 bool CLandRegister::del(const std::string& city, const std::string& address)
 {
-    if (city.empty() || address.empty()) {
+    if (m_Frozen || city.empty() || address.empty()) {
         return false;
     }
 
@@ -232,6 +621,11 @@ bool CLandRegister::del(const std::string& city, const std::string& address)
 
         sortedByRegionId.erase(listRegionIdIt);
 
+        // Deletion consumes a sequence number so the feed stays gapless
+        m_NextAcquisitionOrder++;
+        recordChange(EChangeType::Del, toRemove);
+        invalidateOwnerCache(toRemove);
+
         // Free memory
         delete searchProperty;
         delete toRemove;
@@ -246,7 +640,7 @@ bool CLandRegister::del(const std::string& city, const std::string& address)
 
 bool CLandRegister::del(const std::string &region, unsigned long long id)
 {
-    if (region.empty()) {
+    if (m_Frozen || region.empty()) {
         return false;
     }
 
@@ -279,6 +673,11 @@ bool CLandRegister::del(const std::string &region, unsigned long long id)
         // Remove pointers from list
         sortedByCityAddr.erase(listCityAddressIt);
 
+        // Deletion consumes a sequence number so the feed stays gapless
+        m_NextAcquisitionOrder++;
+        recordChange(EChangeType::Del, toRemove);
+        invalidateOwnerCache(toRemove);
+
         // Free memory
         delete searchProperty;
         delete toRemove;
@@ -297,24 +696,36 @@ bool CLandRegister::getOwner(const std::string& city, const std::string& address
         return false;
     }
 
-    std::string locCity(city);
-    std::string locAddress(address);
+    if (m_Frozen) {
+        size_t row;
+        if (m_Frozen->findCityAddr(city, address, row)) {
+            owner = m_Frozen->owner(row);
+            return true;
+        }
+        return false;
+    }
 
-    m_Property* searchProperty = new m_Property(locCity, locAddress);
+    if (findCachedOwner(m_CityAddrCache, {city, address, 0}, owner)) {
+        return true;
+    }
 
+    auto listCityAddressIt = std::partition_point(sortedByCityAddr.begin(), sortedByCityAddr.end(),
+                                                  [&](const m_Property* property) {
+                                                      if (property->m_City == city)
+                                                      {
+                                                          return property->m_Address < address;
+                                                      }
 
-    auto listCityAddressIt = std::lower_bound(sortedByCityAddr.begin(), sortedByCityAddr.end(), searchProperty,
-                                              CLandRegister::m_Property::CompareLessThan);
+                                                      return property->m_City < city; });
 
-    if (listCityAddressIt != sortedByCityAddr.end() && (*listCityAddressIt)->m_City == searchProperty->m_City
-        && (*listCityAddressIt)->m_Address == searchProperty->m_Address) {
+    if (listCityAddressIt != sortedByCityAddr.end() && (*listCityAddressIt)->m_City == city
+        && (*listCityAddressIt)->m_Address == address) {
         owner = (*listCityAddressIt)->m_Owner;
 
-        delete searchProperty;
+        cacheOwner(m_CityAddrCache, *listCityAddressIt);
         return true;
     }
 
-    delete searchProperty;
     return false;
 }
 
@@ -323,35 +734,42 @@ bool CLandRegister::getOwner(const std::string& region, unsigned long long id, s
         return false;
     }
 
-    std::string locRegion(region);
-    unsigned long long locId(id);
+    if (m_Frozen) {
+        size_t row;
+        if (m_Frozen->findRegionId(region, id, row)) {
+            owner = m_Frozen->owner(row);
+            return true;
+        }
+        return false;
+    }
 
-    m_Property* searchProperty = new m_Property(locRegion, locId);
+    if (findCachedOwner(m_RegionIdCache, {region, std::string_view(), id}, owner)) {
+        return true;
+    }
 
-    auto listRegionIdIt = std::lower_bound(sortedByRegionId.begin(), sortedByRegionId.end(), searchProperty,
-                                        [&](const m_Property* lhs, const m_Property* rhs) {
-                                            if (lhs->m_Region == rhs->m_Region)
-                                            {
-                                                return lhs->m_ID < rhs->m_ID;
-                                            }
+    auto listRegionIdIt = std::partition_point(sortedByRegionId.begin(), sortedByRegionId.end(),
+                                               [&](const m_Property* property) {
+                                                   if (property->m_Region == region)
+                                                   {
+                                                       return property->m_ID < id;
+                                                   }
 
-                                            return lhs->m_Region < rhs->m_Region; });
+                                                   return property->m_Region < region; });
 
-    if (listRegionIdIt != sortedByRegionId.end() && (*listRegionIdIt)->m_Region == searchProperty->m_Region
-        && (*listRegionIdIt)->m_ID == searchProperty->m_ID) {
+    if (listRegionIdIt != sortedByRegionId.end() && (*listRegionIdIt)->m_Region == region
+        && (*listRegionIdIt)->m_ID == id) {
         owner = (*listRegionIdIt)->m_Owner;
 
-        delete searchProperty;
+        cacheOwner(m_RegionIdCache, *listRegionIdIt);
         return true;
     }
 
-    delete searchProperty;
     return false;
 }
 
 bool CLandRegister::newOwner(const std::string& city, const std::string& address, const std::string& owner)
 {
-    if (city.empty() || address.empty()) {
+    if (m_Frozen || city.empty() || address.empty()) {
         return false;
     }
 
@@ -367,6 +785,8 @@ bool CLandRegister::newOwner(const std::string& city, const std::string& address
         && (*listCityAddressIt)->m_Address == searchProperty->m_Address && (*listCityAddressIt)->m_Owner != owner) {
         (*listCityAddressIt)->m_Owner = owner;
         (*listCityAddressIt)->m_AcquisitionTimestamp = m_NextAcquisitionOrder++;
+        recordChange(EChangeType::NewOwner, *listCityAddressIt);
+        invalidateOwnerCache(*listCityAddressIt);
 
 
         delete searchProperty;
@@ -378,7 +798,7 @@ bool CLandRegister::newOwner(const std::string& city, const std::string& address
 }
 
 bool CLandRegister::newOwner(const std::string& region, unsigned long long id, const std::string& owner) {
-    if (region.empty()) {
+    if (m_Frozen || region.empty()) {
         return false;
     }
 
@@ -400,6 +820,8 @@ bool CLandRegister::newOwner(const std::string& region, unsigned long long id, c
         && (*listRegionIdIt)->m_ID == searchProperty->m_ID && (*listRegionIdIt)->m_Owner != owner) {
         (*listRegionIdIt)->m_Owner = owner;
         (*listRegionIdIt)->m_AcquisitionTimestamp = m_NextAcquisitionOrder++;
+        recordChange(EChangeType::NewOwner, *listRegionIdIt);
+        invalidateOwnerCache(*listRegionIdIt);
 
         delete searchProperty;
         return true;
@@ -410,6 +832,10 @@ bool CLandRegister::newOwner(const std::string& region, unsigned long long id, c
 }
 
 CIterator CLandRegister::listByAddr() const {
+    if (m_Frozen) {
+        return CIterator(*this, 0, m_Frozen->rows());
+    }
+
     std::vector<m_Property*> sortedProperties = sortedByCityAddr;
     return CIterator(*this, sortedProperties);
 }
@@ -417,6 +843,10 @@ CIterator CLandRegister::listByAddr() const {
 
 CIterator CLandRegister::listByOwner(const std::string& owner) const
 {
+    if (m_Frozen) {
+        return CIterator(*this, m_Frozen->rowsByOwner(owner));
+    }
+
     std::vector<m_Property*> ownedProperties;
 
     for (const auto& property : sortedByRegionId) {
@@ -434,107 +864,1003 @@ CIterator CLandRegister::listByOwner(const std::string& owner) const
 
 size_t CLandRegister::count(const std::string& owner) const
 {
+    if (m_Frozen) {
+        return m_Frozen->countByOwner(owner);
+    }
+
     return std::count_if(sortedByCityAddr.begin(), sortedByCityAddr.end(),
                          [&](const m_Property* p) {
                              return strcasecmp(p->m_Owner.c_str(), owner.c_str()) == 0;
                          });
 }
 
-bool CIterator::atEnd() const
+bool CLandRegister::freeze()
 {
-    return currentIndex >= sortedProperties.size();
+    // Row numbers in the column store are 32-bit, the sentinel needs one more value
+    if (m_Frozen || sortedByCityAddr.size() >= m_ColumnStore::MAX_ROWS || *m_LiveIterators) {
+        return false;
+    }
+
+    CMemoryUsage usage = memoryUsage();
+    m_LiveBytesBeforeFreeze = usage.m_Properties + usage.m_Strings + usage.m_CityAddrIndex + usage.m_RegionIdIndex
+                              + usage.m_OwnerIndex;
+    m_Frozen = std::make_unique<m_ColumnStore>(sortedByCityAddr, sortedByRegionId);
+
+    // Free memory, the column store now owns all data
+    for (m_Property* property : sortedByCityAddr) {
+        delete property;
+    }
+    std::vector<m_Property*>().swap(sortedByCityAddr);
+    std::vector<m_Property*>().swap(sortedByRegionId);
+    std::vector<m_Property*>().swap(sortedByOwner);
+    setOwnerCacheCapacity(0);
+
+    return true;
 }
 
-void CIterator::next()
+bool CLandRegister::frozen() const
 {
-    if(!atEnd())
-    {
-        currentIndex++;
+    return m_Frozen != nullptr;
+}
+
+bool CLandRegister::freezeReport(size_t& liveBytes, size_t& frozenBytes) const
+{
+    if (!m_Frozen) {
+        return false;
     }
+
+    liveBytes = m_LiveBytesBeforeFreeze;
+    frozenBytes = sizeof(m_ColumnStore) + m_Frozen->memoryUsage();
+    return true;
 }
 
-std::string CIterator::city() const
+size_t CLandRegister::StringHeapBytes(const std::string& value)
 {
-    std::cout << sortedProperties[currentIndex]->m_City << std::endl;
-    return (!atEnd()) ? sortedProperties[currentIndex]->m_City : "";
+    // Short strings live inside the object itself
+    const char* object = reinterpret_cast<const char*>(&value);
+    if (value.data() >= object && value.data() < object + sizeof(value)) {
+        return 0;
+    }
+    return value.capacity() + 1;
 }
 
-std::string CIterator::addr() const
+size_t CLandRegister::CMemoryUsage::total() const
 {
-    return (!atEnd()) ? sortedProperties[currentIndex]->m_Address : "";
+    return m_Properties + m_Strings + m_CityAddrIndex + m_RegionIdIndex + m_OwnerIndex + m_Iterators + m_ChangeLog
+           + m_OwnerCache + m_ColumnStore;
 }
 
-std::string CIterator::owner() const
+CLandRegister::CMemoryUsage CLandRegister::memoryUsage() const
 {
-    return (!atEnd()) ? sortedProperties[currentIndex]->m_Owner : "";
+    CMemoryUsage usage = {};
+
+    usage.m_Properties = sortedByCityAddr.size() * sizeof(m_Property);
+    for (const m_Property* property : sortedByCityAddr) {
+        usage.m_Strings += StringHeapBytes(property->m_City) + StringHeapBytes(property->m_Address)
+                           + StringHeapBytes(property->m_Region) + StringHeapBytes(property->m_Owner);
+    }
+
+    usage.m_CityAddrIndex = sortedByCityAddr.capacity() * sizeof(m_Property*);
+    usage.m_RegionIdIndex = sortedByRegionId.capacity() * sizeof(m_Property*);
+    usage.m_OwnerIndex = sortedByOwner.capacity() * sizeof(m_Property*);
+    usage.m_Iterators = *m_IteratorBytes;
+
+    // Payloads are counted without the shared_ptr control block
+    usage.m_ChangeLog = 0;
+    if (m_ChangeLog) {
+        usage.m_ChangeLog = m_ChangeLogCapacity * sizeof(m_ChangeSlot);
+        for (size_t i = 0; i < m_ChangeLogCapacity; i++) {
+            std::shared_ptr<const CChange> change = std::atomic_load_explicit(&m_ChangeLog[i].m_Change, std::memory_order_acquire);
+            if (change) {
+                usage.m_ChangeLog += sizeof(CChange) + StringHeapBytes(change->m_City) + StringHeapBytes(change->m_Address)
+                                     + StringHeapBytes(change->m_Region) + StringHeapBytes(change->m_Owner);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_OwnerCacheMutex);
+        usage.m_OwnerCache = m_CityAddrCache.memoryUsage() + m_RegionIdCache.memoryUsage();
+    }
+
+    if (m_Frozen) {
+        usage.m_ColumnStore = sizeof(m_ColumnStore) + m_Frozen->memoryUsage();
+    }
+
+    return usage;
 }
 
-std::string CIterator::region() const
+void CLandRegister::shrinkToFit()
 {
-    return (!atEnd()) ? sortedProperties[currentIndex]->m_Region : "";
+    sortedByCityAddr.shrink_to_fit();
+    sortedByRegionId.shrink_to_fit();
+    sortedByOwner.shrink_to_fit();
+
+    // newOwner may leave a long owner buffer behind a short name
+    for (m_Property* property : sortedByCityAddr) {
+        property->m_Owner.shrink_to_fit();
+    }
+
+    m_CityAddrCache.shrinkToFit();
+    m_RegionIdCache.shrinkToFit();
 }
 
-unsigned CIterator::id() const
+CLandRegister::m_ColumnStore::m_ColumnStore(const std::vector<m_Property*>& byCityAddr,
+                                            const std::vector<m_Property*>& byRegionId)
 {
-    return (!atEnd()) ? sortedProperties[currentIndex]->m_ID : 0;
+    size_t count = byCityAddr.size();
+
+    // Owners are unordered, collect the distinct ones without copying every string
+    std::unordered_set<std::string_view> owners;
+    for (const m_Property* property : byCityAddr) {
+        owners.insert(property->m_Owner);
+    }
+    m_Owners.assign(owners.begin(), owners.end());
+    std::unordered_set<std::string_view>().swap(owners);
+    std::sort(m_Owners.begin(), m_Owners.end());
+
+    // Row of each parcel, sorted by pointer so the region/id pass can find it
+    std::vector<std::pair<const m_Property*, uint32_t>> rowOf;
+    rowOf.reserve(count);
+
+    // Columns in city/address order, cities come in sorted runs
+    m_OwnerCode.resize(count);
+    const std::string* previousAddress = nullptr;
+    for (size_t row = 0; row < count; row++) {
+        const m_Property* property = byCityAddr[row];
+        rowOf.emplace_back(property, row);
+
+        if (m_Cities.empty() || m_Cities.back() != property->m_City) {
+            m_Cities.push_back(property->m_City);
+            m_CityStart.push_back(row);
+        }
+        m_OwnerCode[row] = CodeOf(m_Owners, property->m_Owner);
+
+        size_t prefix = 0;
+        if (row % BLOCK_SIZE == 0) {
+            m_AddrBlocks.push_back(m_AddrBytes.size());
+        } else {
+            while (prefix < previousAddress->size() && prefix < property->m_Address.size()
+                   && (*previousAddress)[prefix] == property->m_Address[prefix]) {
+                prefix++;
+            }
+        }
+        PutVarint(m_AddrBytes, prefix);
+        PutVarint(m_AddrBytes, property->m_Address.size() - prefix);
+        m_AddrBytes.append(property->m_Address, prefix, std::string::npos);
+        previousAddress = &property->m_Address;
+    }
+    m_CityStart.push_back(count);
+    std::sort(rowOf.begin(), rowOf.end());
+
+    // Columns in region/id order, regions come in sorted runs
+    m_RegionIdRows.resize(count);
+    m_IdPosition.resize(count);
+    for (size_t position = 0; position < count; position++) {
+        const m_Property* property = byRegionId[position];
+        uint32_t row = std::lower_bound(rowOf.begin(), rowOf.end(), std::make_pair(property, uint32_t(0)))->second;
+        m_RegionIdRows[position] = row;
+        m_IdPosition[row] = position;
+
+        bool regionStart = m_Regions.empty() || m_Regions.back() != property->m_Region;
+        if (regionStart) {
+            m_Regions.push_back(property->m_Region);
+            m_RegionStart.push_back(position);
+        }
+
+        if (position % BLOCK_SIZE == 0) {
+            m_IdBlocks.push_back(m_IdBytes.size());
+        }
+        if (position % BLOCK_SIZE == 0 || regionStart) {
+            PutVarint(m_IdBytes, property->m_ID);
+        } else {
+            PutVarint(m_IdBytes, property->m_ID - byRegionId[position - 1]->m_ID);
+        }
+    }
+    m_RegionStart.push_back(count);
+    std::vector<std::pair<const m_Property*, uint32_t>>().swap(rowOf);
+
+    // Acquisition order for listByOwner
+    m_RowsByAcquisition.resize(count);
+    for (size_t row = 0; row < count; row++) {
+        m_RowsByAcquisition[row] = row;
+    }
+    std::sort(m_RowsByAcquisition.begin(), m_RowsByAcquisition.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return byCityAddr[lhs]->m_AcquisitionTimestamp < byCityAddr[rhs]->m_AcquisitionTimestamp; });
+
+    m_Cities.shrink_to_fit();
+    m_Regions.shrink_to_fit();
+    m_CityStart.shrink_to_fit();
+    m_RegionStart.shrink_to_fit();
+    m_AddrBytes.shrink_to_fit();
+    m_IdBytes.shrink_to_fit();
 }
 
+size_t CLandRegister::m_ColumnStore::rows() const
+{
+    return m_OwnerCode.size();
+}
 
-#ifndef __PROGTEST__
-static void test0 ()
+std::string CLandRegister::m_ColumnStore::city(size_t row) const
 {
-    CLandRegister x;
-    std::string owner;
+    auto cityIt = std::upper_bound(m_CityStart.begin(), m_CityStart.end(), row);
+    return m_Cities[cityIt - m_CityStart.begin() - 1];
+}
 
-    assert ( x . add ( "Prague", "Thakurova", "Dejvice", 12345 ) );
-    assert ( x . add ( "Prague", "Evropska", "Vokovice", 12345 ) );
-    assert ( x . add ( "Prague", "Technicka", "Dejvice", 9873 ) );
-    assert ( x . add ( "Plzen", "Evropska", "Plzen mesto", 78901 ) );
-    assert ( x . add ( "Liberec", "Evropska", "Librec", 4552 ) );
-    CIterator i0 = x . listByAddr ();
-    assert ( ! i0 . atEnd ()
-             && i0 . city () == "Liberec"
-             && i0 . addr () == "Evropska"
-             && i0 . region () == "Librec"
-             && i0 . id () == 4552
-             && i0 . owner () == "" );
-    i0 . next ();
-    assert ( ! i0 . atEnd ()
-             && i0 . city () == "Plzen"
-             && i0 . addr () == "Evropska"
-             && i0 . region () == "Plzen mesto"
-             && i0 . id () == 78901
-             && i0 . owner () == "" );
-    i0 . next ();
-    assert ( ! i0 . atEnd ()
-             && i0 . city () == "Prague"
-             && i0 . addr () == "Evropska"
-             && i0 . region () == "Vokovice"
-             && i0 . id () == 12345
-             && i0 . owner () == "" );
-    i0 . next ();
-    assert ( ! i0 . atEnd ()
-             && i0 . city () == "Prague"
-             && i0 . addr () == "Technicka"
-             && i0 . region () == "Dejvice"
-             && i0 . id () == 9873
-             && i0 . owner () == "" );
-    i0 . next ();
-    assert ( ! i0 . atEnd ()
-             && i0 . city () == "Prague"
-             && i0 . addr () == "Thakurova"
-             && i0 . region () == "Dejvice"
-             && i0 . id () == 12345
-             && i0 . owner () == "" );
-    i0 . next ();
-    assert ( i0 . atEnd () );
+std::string CLandRegister::m_ColumnStore::address(size_t row) const
+{
+    // Decode forward from the start of the block
+    size_t offset = m_AddrBlocks[row / BLOCK_SIZE];
+    std::string address;
+    for (size_t current = row - row % BLOCK_SIZE; current <= row; current++) {
+        size_t prefix = GetVarint(m_AddrBytes, offset);
+        size_t suffix = GetVarint(m_AddrBytes, offset);
+        address.resize(prefix);
+        address.append(m_AddrBytes, offset, suffix);
+        offset += suffix;
+    }
+    return address;
+}
 
-    assert ( x . count ( "" ) == 5 );
-    CIterator i1 = x . listByOwner ( "" );
-    assert ( ! i1 . atEnd ()
-             && i1 . city () == "Prague"
-             && i1 . addr () == "Thakurova"
-             && i1 . region () == "Dejvice"
+std::string CLandRegister::m_ColumnStore::region(size_t row) const
+{
+    auto regionIt = std::upper_bound(m_RegionStart.begin(), m_RegionStart.end(), m_IdPosition[row]);
+    return m_Regions[regionIt - m_RegionStart.begin() - 1];
+}
+
+unsigned long long CLandRegister::m_ColumnStore::id(size_t row) const
+{
+    return idAt(m_IdPosition[row]);
+}
+
+const std::string& CLandRegister::m_ColumnStore::owner(size_t row) const
+{
+    return m_Owners[m_OwnerCode[row]];
+}
+
+unsigned long long CLandRegister::m_ColumnStore::idAt(size_t position) const
+{
+    size_t offset = m_IdBlocks[position / BLOCK_SIZE];
+    size_t current = position - position % BLOCK_SIZE;
+    unsigned long long id = GetVarint(m_IdBytes, offset);
+
+    // Values restart at every region boundary inside the block
+    auto regionIt = std::upper_bound(m_RegionStart.begin(), m_RegionStart.end(), current);
+    for (current++; current <= position; current++) {
+        unsigned long long value = GetVarint(m_IdBytes, offset);
+        if (current == *regionIt) {
+            id = value;
+            regionIt++;
+        } else {
+            id += value;
+        }
+    }
+    return id;
+}
+
+bool CLandRegister::m_ColumnStore::findCityAddr(const std::string& city, const std::string& addr, size_t& row) const
+{
+    uint32_t cityCode = CodeOf(m_Cities, city);
+    if (cityCode == m_Cities.size()) {
+        return false;
+    }
+
+    // Every dictionary entry owns at least one row, so the next start ends the run
+    size_t low = m_CityStart[cityCode];
+    size_t high = m_CityStart[cityCode + 1];
+    size_t end = high;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (address(middle) < addr) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    if (low < end && address(low) == addr) {
+        row = low;
+        return true;
+    }
+    return false;
+}
+
+bool CLandRegister::m_ColumnStore::findRegionId(const std::string& region, unsigned long long id, size_t& row) const
+{
+    uint32_t regionCode = CodeOf(m_Regions, region);
+    if (regionCode == m_Regions.size()) {
+        return false;
+    }
+
+    size_t low = m_RegionStart[regionCode];
+    size_t high = m_RegionStart[regionCode + 1];
+    size_t end = high;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (idAt(middle) < id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    if (low < end && idAt(low) == id) {
+        row = m_RegionIdRows[low];
+        return true;
+    }
+    return false;
+}
+
+std::vector<bool> CLandRegister::m_ColumnStore::ownerMatches(const std::string& owner) const
+{
+    // Owners match case-insensitively, resolve the matching codes once
+    std::vector<bool> matches(m_Owners.size());
+    for (size_t code = 0; code < m_Owners.size(); code++) {
+        matches[code] = strcasecmp(m_Owners[code].c_str(), owner.c_str()) == 0;
+    }
+    return matches;
+}
+
+std::vector<uint32_t> CLandRegister::m_ColumnStore::rowsByOwner(const std::string& owner) const
+{
+    std::vector<bool> matches = ownerMatches(owner);
+
+    std::vector<uint32_t> ownedRows;
+    for (uint32_t row : m_RowsByAcquisition) {
+        if (matches[m_OwnerCode[row]]) {
+            ownedRows.push_back(row);
+        }
+    }
+    return ownedRows;
+}
+
+size_t CLandRegister::m_ColumnStore::countByOwner(const std::string& owner) const
+{
+    std::vector<bool> matches = ownerMatches(owner);
+
+    size_t owned = 0;
+    for (uint32_t code : m_OwnerCode) {
+        owned += matches[code];
+    }
+    return owned;
+}
+
+size_t CLandRegister::m_ColumnStore::memoryUsage() const
+{
+    size_t bytes = 0;
+    for (const std::vector<std::string>* dictionary : {&m_Cities, &m_Regions, &m_Owners}) {
+        bytes += dictionary->capacity() * sizeof(std::string);
+        for (const std::string& value : *dictionary) {
+            bytes += StringHeapBytes(value);
+        }
+    }
+
+    for (const std::vector<uint32_t>* column : {&m_CityStart, &m_OwnerCode, &m_IdPosition, &m_RowsByAcquisition,
+                                                &m_RegionStart, &m_RegionIdRows}) {
+        bytes += column->capacity() * sizeof(uint32_t);
+    }
+    bytes += (m_AddrBlocks.capacity() + m_IdBlocks.capacity()) * sizeof(uint64_t);
+
+    return bytes + StringHeapBytes(m_AddrBytes) + StringHeapBytes(m_IdBytes);
+}
+
+uint32_t CLandRegister::m_ColumnStore::CodeOf(const std::vector<std::string>& dictionary, const std::string& value)
+{
+    auto valueIt = std::lower_bound(dictionary.begin(), dictionary.end(), value);
+    if (valueIt == dictionary.end() || *valueIt != value) {
+        return dictionary.size();
+    }
+    return valueIt - dictionary.begin();
+}
+
+void CLandRegister::m_ColumnStore::PutVarint(std::string& bytes, unsigned long long value)
+{
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<char>(value));
+}
+
+unsigned long long CLandRegister::m_ColumnStore::GetVarint(const std::string& bytes, size_t& offset)
+{
+    unsigned long long value = 0;
+    for (int shift = 0; ; shift += 7) {
+        unsigned char byte = bytes[offset++];
+        value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+}
+
+void CLandRegister::recordChange(EChangeType type, const m_Property* property)
+{
+    // Sequence was already consumed by the caller
+    unsigned long long sequence = m_NextAcquisitionOrder - 1;
+
+    if (m_ChangeLog) {
+        m_ChangeSlot& slot = m_ChangeLog[sequence % m_ChangeLogCapacity];
+        std::shared_ptr<const CChange> change(new CChange { type, sequence, property->m_City, property->m_Address,
+                                                            property->m_Region, property->m_ID, property->m_Owner });
+        // Invalidate the stamp first so a reader that loaded the old one notices the swap
+        slot.m_Stamp.store(0, std::memory_order_release);
+        std::atomic_store_explicit(&slot.m_Change, std::move(change), std::memory_order_release);
+        slot.m_Stamp.store(sequence + 1, std::memory_order_release);
+    }
+
+    m_ChangeHead.store(sequence + 1, std::memory_order_release);
+}
+
+void CLandRegister::invalidateOwnerCache(const m_Property* property)
+{
+    // Capacity only changes under exclusive access, safe to test without the lock
+    if (!m_CityAddrCache.m_Capacity) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_OwnerCacheMutex);
+    m_CityAddrCache.erase(property);
+    m_RegionIdCache.erase(property);
+}
+
+bool CLandRegister::findCachedOwner(m_OwnerCache& cache, const m_CacheKey& key, std::string& owner) const
+{
+    if (!cache.m_Capacity) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_OwnerCacheMutex);
+    if (const m_Property* cached = cache.find(key)) {
+        owner = cached->m_Owner;
+        m_OwnerCacheHits++;
+        return true;
+    }
+    m_OwnerCacheMisses++;
+    return false;
+}
+
+void CLandRegister::cacheOwner(m_OwnerCache& cache, m_Property* property) const
+{
+    if (cache.m_Capacity) {
+        std::lock_guard<std::mutex> lock(m_OwnerCacheMutex);
+        cache.insert(property);
+    }
+}
+
+void CLandRegister::setOwnerCacheCapacity(size_t capacity)
+{
+    if (m_Frozen) {
+        capacity = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_OwnerCacheMutex);
+    m_CityAddrCache.clear();
+    m_RegionIdCache.clear();
+    m_CityAddrCache.m_Capacity = capacity;
+    m_RegionIdCache.m_Capacity = capacity;
+}
+
+size_t CLandRegister::ownerCacheHits() const
+{
+    std::lock_guard<std::mutex> lock(m_OwnerCacheMutex);
+    return m_OwnerCacheHits;
+}
+
+size_t CLandRegister::ownerCacheMisses() const
+{
+    std::lock_guard<std::mutex> lock(m_OwnerCacheMutex);
+    return m_OwnerCacheMisses;
+}
+
+bool CLandRegister::m_CacheKey::operator == (const m_CacheKey& otherKey) const
+{
+    return m_ID == otherKey.m_ID && m_First == otherKey.m_First && m_Second == otherKey.m_Second;
+}
+
+size_t CLandRegister::m_CacheKey::m_Hash::operator () (const m_CacheKey& key) const
+{
+    size_t hash = std::hash<std::string_view>()(key.m_First);
+    hash ^= std::hash<std::string_view>()(key.m_Second) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<unsigned long long>()(key.m_ID) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+CLandRegister::m_OwnerCache::m_OwnerCache(bool byRegion) : m_ByRegion(byRegion) {}
+
+CLandRegister::m_CacheKey CLandRegister::m_OwnerCache::keyOf(const m_Property* property) const
+{
+    if (m_ByRegion) {
+        return {property->m_Region, std::string_view(), property->m_ID};
+    }
+    return {property->m_City, property->m_Address, 0};
+}
+
+CLandRegister::m_Property* CLandRegister::m_OwnerCache::find(const m_CacheKey& key)
+{
+    auto indexIt = m_Index.find(key);
+    if (indexIt == m_Index.end()) {
+        return nullptr;
+    }
+
+    // Move to front as most recently used
+    m_Entries.splice(m_Entries.begin(), m_Entries, indexIt->second);
+    return *indexIt->second;
+}
+
+void CLandRegister::m_OwnerCache::insert(m_Property* property)
+{
+    // Another reader may have cached it between our miss and now
+    if (m_Index.count(keyOf(property))) {
+        return;
+    }
+
+    // Evict least recently used entry
+    if (m_Entries.size() >= m_Capacity) {
+        m_Index.erase(keyOf(m_Entries.back()));
+        m_Entries.pop_back();
+    }
+
+    m_Entries.push_front(property);
+    m_Index[keyOf(property)] = m_Entries.begin();
+}
+
+void CLandRegister::m_OwnerCache::erase(const m_Property* property)
+{
+    auto indexIt = m_Index.find(keyOf(property));
+    if (indexIt != m_Index.end()) {
+        m_Entries.erase(indexIt->second);
+        m_Index.erase(indexIt);
+    }
+}
+
+size_t CLandRegister::m_OwnerCache::memoryUsage() const
+{
+    // This is an estimate, node layouts are up to the standard library. It counts a
+    // list node as two links plus the entry and a hash node as one link plus the
+    // entry, anything an implementation adds on top is not included.
+    size_t bytes = m_Index.bucket_count() > 1 ? m_Index.bucket_count() * sizeof(void*) : 0;
+    bytes += m_Entries.size() * (2 * sizeof(void*) + sizeof(m_Property*));
+    bytes += m_Index.size() * (sizeof(void*) + sizeof(decltype(m_Index)::value_type));
+    return bytes;
+}
+
+void CLandRegister::m_OwnerCache::shrinkToFit()
+{
+    m_Index.rehash(0);
+}
+
+void CLandRegister::m_OwnerCache::clear()
+{
+    m_Entries.clear();
+    // Swap rather than clear so the bucket array is released too
+    decltype(m_Index)().swap(m_Index);
+}
+
+CChangeFeed CLandRegister::subscribe(unsigned long long fromSequence)
+{
+    if (!m_ChangeLog && m_ChangeLogCapacity) {
+        m_ChangeLog = std::make_unique<m_ChangeSlot[]>(m_ChangeLogCapacity);
+        m_ChangeLogStart = m_NextAcquisitionOrder;
+    }
+
+    return CChangeFeed(*this, fromSequence);
+}
+
+unsigned long long CLandRegister::nextSequence() const
+{
+    return m_ChangeHead.load(std::memory_order_acquire);
+}
+
+bool CChangeFeed::needsResync() const
+{
+    unsigned long long head = landRegister.nextSequence();
+    size_t capacity = landRegister.m_ChangeLogCapacity;
+
+    // Oldest change still available, nothing is when the feed is disabled
+    unsigned long long oldest = head;
+    if (landRegister.m_ChangeLog) {
+        oldest = std::max(landRegister.m_ChangeLogStart, head > capacity ? head - capacity : 0);
+    }
+
+    return nextSequence < oldest;
+}
+
+bool CChangeFeed::poll(CLandRegister::CChange& change)
+{
+    if (needsResync() || nextSequence >= landRegister.nextSequence()) {
+        return false;
+    }
+
+    // The writer may lap us between the checks above and the copy, the stamp is
+    // re-read afterwards and a mismatch leaves the overwrite to needsResync()
+    CLandRegister::m_ChangeSlot& slot = landRegister.m_ChangeLog[nextSequence % landRegister.m_ChangeLogCapacity];
+    if (slot.m_Stamp.load(std::memory_order_acquire) != nextSequence + 1) {
+        return false;
+    }
+    std::shared_ptr<const CLandRegister::CChange> published = std::atomic_load_explicit(&slot.m_Change, std::memory_order_acquire);
+    if (!published || published->m_Sequence != nextSequence
+        || slot.m_Stamp.load(std::memory_order_acquire) != nextSequence + 1) {
+        return false;
+    }
+
+    change = *published;
+    nextSequence++;
+
+    return true;
+}
+
+void CChangeFeed::resync()
+{
+    nextSequence = landRegister.nextSequence();
+}
+
+unsigned long long CChangeFeed::sequence() const
+{
+    return nextSequence;
+}
+
+size_t CIterator::footprint() const
+{
+    return sortedProperties.capacity() * sizeof(CLandRegister::m_Property*) + frozenRows.capacity() * sizeof(uint32_t);
+}
+
+size_t CIterator::row() const
+{
+    return rowRange ? currentIndex : frozenRows[currentIndex];
+}
+
+bool CIterator::atEnd() const
+{
+    if (rowRange) {
+        return currentIndex >= rangeEnd;
+    }
+    return currentIndex >= (frozen ? frozenRows.size() : sortedProperties.size());
+}
+
+void CIterator::next()
+{
+    if(!atEnd())
+    {
+        currentIndex++;
+    }
+}
+
+std::string CIterator::city() const
+{
+    if (atEnd()) {
+        return "";
+    }
+    return frozen ? landRegister.m_Frozen->city(row()) : sortedProperties[currentIndex]->m_City;
+}
+
+std::string CIterator::addr() const
+{
+    if (atEnd()) {
+        return "";
+    }
+    return frozen ? landRegister.m_Frozen->address(row()) : sortedProperties[currentIndex]->m_Address;
+}
+
+std::string CIterator::owner() const
+{
+    if (atEnd()) {
+        return "";
+    }
+    return frozen ? landRegister.m_Frozen->owner(row()) : sortedProperties[currentIndex]->m_Owner;
+}
+
+std::string CIterator::region() const
+{
+    if (atEnd()) {
+        return "";
+    }
+    return frozen ? landRegister.m_Frozen->region(row()) : sortedProperties[currentIndex]->m_Region;
+}
+
+unsigned CIterator::id() const
+{
+    if (atEnd()) {
+        return 0;
+    }
+    return frozen ? landRegister.m_Frozen->id(row()) : sortedProperties[currentIndex]->m_ID;
+}
+
+
+bool CAsyncLookup::COwnerLookup::await_ready()
+{
+    // Empty keys never match, no need to wait for a batch
+    if (byRegion ? region.empty() : city.empty() || addr.empty()) {
+        return true;
+    }
+
+    // Owner cache hits complete without suspending, same accounting as getOwner
+    const CLandRegister& landRegister = front.landRegister;
+    if (byRegion) {
+        found = landRegister.findCachedOwner(landRegister.m_RegionIdCache, {region, std::string_view(), id}, owner);
+    } else {
+        found = landRegister.findCachedOwner(landRegister.m_CityAddrCache, {city, addr, 0}, owner);
+    }
+    return found;
+}
+
+void CAsyncLookup::COwnerLookup::await_suspend(std::coroutine_handle<CLookupTask::promise_type> handle)
+{
+    this->handle = handle;
+    front.pendingLookups.push_back(this);
+}
+
+bool CAsyncLookup::COwnerLookup::await_resume() const noexcept
+{
+    return found;
+}
+
+CAsyncLookup::COwnerLookup CAsyncLookup::getOwner(const std::string& city, const std::string& addr, std::string& owner)
+{
+    return COwnerLookup(*this, city, addr, owner);
+}
+
+CAsyncLookup::COwnerLookup CAsyncLookup::getOwner(const std::string& region, unsigned long long id, std::string& owner)
+{
+    return COwnerLookup(*this, region, id, owner);
+}
+
+size_t CAsyncLookup::pending() const
+{
+    return pendingLookups.size();
+}
+
+size_t CAsyncLookup::run()
+{
+    size_t resolved = 0;
+
+    // Resumed coroutines may issue further lookups, keep going until quiet
+    while (!pendingLookups.empty()) {
+        std::vector<COwnerLookup*> lookups;
+        lookups.swap(pendingLookups);
+
+        for (size_t start = 0; start < lookups.size(); start += batchSize) {
+            std::vector<COwnerLookup*> batch(lookups.begin() + start,
+                                             lookups.begin() + std::min(start + batchSize, lookups.size()));
+            resolveBatch(batch);
+
+            // Lookup objects live in the coroutine frames, resuming may destroy them
+            std::vector<std::coroutine_handle<>> handles;
+            for (const COwnerLookup* lookup : batch) {
+                handles.push_back(lookup->handle);
+            }
+            for (std::coroutine_handle<> handle : handles) {
+                handle.resume();
+            }
+            resolved += batch.size();
+        }
+    }
+
+    return resolved;
+}
+
+void CAsyncLookup::resolveBatch(std::vector<COwnerLookup*>& batch)
+{
+    if (landRegister.m_Frozen) {
+        for (COwnerLookup* lookup : batch) {
+            lookup->found = lookup->byRegion ? landRegister.getOwner(lookup->region, lookup->id, lookup->owner)
+                                             : landRegister.getOwner(lookup->city, lookup->addr, lookup->owner);
+        }
+        return;
+    }
+
+    std::vector<COwnerLookup*> cityAddrLookups;
+    std::vector<COwnerLookup*> regionIdLookups;
+    for (COwnerLookup* lookup : batch) {
+        (lookup->byRegion ? regionIdLookups : cityAddrLookups).push_back(lookup);
+    }
+
+    resolveCityAddr(cityAddrLookups);
+    resolveRegionId(regionIdLookups);
+}
+
+void CAsyncLookup::resolveCityAddr(std::vector<COwnerLookup*>& lookups)
+{
+    // Neighbouring keys share their search paths, sorting keeps those cache lines hot
+    std::sort(lookups.begin(), lookups.end(), [](const COwnerLookup* lhs, const COwnerLookup* rhs) {
+        if (lhs->city == rhs->city)
+        {
+            return lhs->addr < rhs->addr;
+        }
+
+        return lhs->city < rhs->city; });
+
+    const std::vector<CLandRegister::m_Property*>& properties = landRegister.sortedByCityAddr;
+    std::vector<size_t> positions;
+    LowerBoundBatch(properties, lookups, [](const CLandRegister::m_Property* property, const COwnerLookup* lookup) {
+        if (property->m_City == lookup->city)
+        {
+            return property->m_Address < lookup->addr;
+        }
+
+        return property->m_City < lookup->city; }, positions);
+
+    for (size_t i = 0; i < lookups.size(); i++) {
+        if (positions[i] != properties.size() && properties[positions[i]]->m_City == lookups[i]->city
+            && properties[positions[i]]->m_Address == lookups[i]->addr) {
+            lookups[i]->owner = properties[positions[i]]->m_Owner;
+            lookups[i]->found = true;
+            landRegister.cacheOwner(landRegister.m_CityAddrCache, properties[positions[i]]);
+        }
+    }
+}
+
+void CAsyncLookup::resolveRegionId(std::vector<COwnerLookup*>& lookups)
+{
+    std::sort(lookups.begin(), lookups.end(), [](const COwnerLookup* lhs, const COwnerLookup* rhs) {
+        if (lhs->region == rhs->region)
+        {
+            return lhs->id < rhs->id;
+        }
+
+        return lhs->region < rhs->region; });
+
+    const std::vector<CLandRegister::m_Property*>& properties = landRegister.sortedByRegionId;
+    std::vector<size_t> positions;
+    LowerBoundBatch(properties, lookups, [](const CLandRegister::m_Property* property, const COwnerLookup* lookup) {
+        if (property->m_Region == lookup->region)
+        {
+            return property->m_ID < lookup->id;
+        }
+
+        return property->m_Region < lookup->region; }, positions);
+
+    for (size_t i = 0; i < lookups.size(); i++) {
+        if (positions[i] != properties.size() && properties[positions[i]]->m_Region == lookups[i]->region
+            && properties[positions[i]]->m_ID == lookups[i]->id) {
+            lookups[i]->owner = properties[positions[i]]->m_Owner;
+            lookups[i]->found = true;
+            landRegister.cacheOwner(landRegister.m_RegionIdCache, properties[positions[i]]);
+        }
+    }
+}
+
+void CAsyncLookup::Prefetch(const void* address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#endif
+}
+
+template <typename TLess>
+void CAsyncLookup::LowerBoundBatch(const std::vector<CLandRegister::m_Property*>& properties,
+                                   const std::vector<COwnerLookup*>& lookups, TLess less, std::vector<size_t>& positions)
+{
+    positions.assign(lookups.size(), 0);
+    if (properties.empty()) {
+        return;
+    }
+
+    // All keys step through the same search depth together, every round first issues
+    // the loads for the whole batch and only then compares, so the misses overlap
+    std::vector<const CLandRegister::m_Property*> probes(lookups.size());
+    size_t length = properties.size();
+    while (length > 1) {
+        size_t half = length / 2;
+        for (size_t i = 0; i < lookups.size(); i++) {
+            probes[i] = properties[positions[i] + half];
+            Prefetch(probes[i]);
+        }
+        for (size_t i = 0; i < lookups.size(); i++) {
+            if (less(probes[i], lookups[i])) {
+                positions[i] += half;
+            }
+            Prefetch(&properties[positions[i] + (length - half) / 2]);
+        }
+        length -= half;
+    }
+
+    for (size_t i = 0; i < lookups.size(); i++) {
+        if (less(properties[positions[i]], lookups[i])) {
+            positions[i]++;
+        }
+    }
+}
+
+#ifndef __PROGTEST__
+// Allocation tracking for the memory accounting test, every block carries its size in front
+static std::atomic<size_t> g_AllocatedBytes ( 0 );
+static const size_t ALLOCATION_HEADER = alignof(std::max_align_t);
+
+void * operator new ( size_t size )
+{
+    char * block = static_cast<char *> ( malloc ( size + ALLOCATION_HEADER ) );
+    if ( ! block )
+        throw std::bad_alloc ();
+    * reinterpret_cast<size_t *> ( block ) = size;
+    g_AllocatedBytes += size;
+    return block + ALLOCATION_HEADER;
+}
+
+void operator delete ( void * pointer ) noexcept
+{
+    if ( ! pointer )
+        return;
+    // Step back through an integer, the optimiser would otherwise flag the header read as out of bounds
+    char * block = reinterpret_cast<char *> ( reinterpret_cast<uintptr_t> ( pointer ) - ALLOCATION_HEADER );
+    g_AllocatedBytes -= * reinterpret_cast<size_t *> ( block );
+    free ( block );
+}
+
+void * operator new[] ( size_t size )
+{
+    return operator new ( size );
+}
+
+void operator delete[] ( void * pointer ) noexcept
+{
+    operator delete ( pointer );
+}
+
+void operator delete ( void * pointer, size_t ) noexcept
+{
+    operator delete ( pointer );
+}
+
+void operator delete[] ( void * pointer, size_t ) noexcept
+{
+    operator delete ( pointer );
+}
+
+static void test0 ()
+{
+    CLandRegister x;
+    std::string owner;
+
+    assert ( x . add ( "Prague", "Thakurova", "Dejvice", 12345 ) );
+    assert ( x . add ( "Prague", "Evropska", "Vokovice", 12345 ) );
+    assert ( x . add ( "Prague", "Technicka", "Dejvice", 9873 ) );
+    assert ( x . add ( "Plzen", "Evropska", "Plzen mesto", 78901 ) );
+    assert ( x . add ( "Liberec", "Evropska", "Librec", 4552 ) );
+    CIterator i0 = x . listByAddr ();
+    assert ( ! i0 . atEnd ()
+             && i0 . city () == "Liberec"
+             && i0 . addr () == "Evropska"
+             && i0 . region () == "Librec"
+             && i0 . id () == 4552
+             && i0 . owner () == "" );
+    i0 . next ();
+    assert ( ! i0 . atEnd ()
+             && i0 . city () == "Plzen"
+             && i0 . addr () == "Evropska"
+             && i0 . region () == "Plzen mesto"
+             && i0 . id () == 78901
+             && i0 . owner () == "" );
+    i0 . next ();
+    assert ( ! i0 . atEnd ()
+             && i0 . city () == "Prague"
+             && i0 . addr () == "Evropska"
+             && i0 . region () == "Vokovice"
+             && i0 . id () == 12345
+             && i0 . owner () == "" );
+    i0 . next ();
+    assert ( ! i0 . atEnd ()
+             && i0 . city () == "Prague"
+             && i0 . addr () == "Technicka"
+             && i0 . region () == "Dejvice"
+             && i0 . id () == 9873
+             && i0 . owner () == "" );
+    i0 . next ();
+    assert ( ! i0 . atEnd ()
+             && i0 . city () == "Prague"
+             && i0 . addr () == "Thakurova"
+             && i0 . region () == "Dejvice"
+             && i0 . id () == 12345
+             && i0 . owner () == "" );
+    i0 . next ();
+    assert ( i0 . atEnd () );
+
+    assert ( x . count ( "" ) == 5 );
+    CIterator i1 = x . listByOwner ( "" );
+    assert ( ! i1 . atEnd ()
+             && i1 . city () == "Prague"
+             && i1 . addr () == "Thakurova"
+             && i1 . region () == "Dejvice"
              && i1 . id () == 12345
              && i1 . owner () == "" );
     i1 . next ();
@@ -766,10 +2092,380 @@ static void test1 ()
     assert (x . add ("Tokyo", "Nagana", "Tokyo City", 12020203993));
 }
 
+static void test2 ()
+{
+    CLandRegister x ( 4 );
+    CLandRegister::CChange change;
+
+    CChangeFeed f0 = x . subscribe ( x . nextSequence () );
+    assert ( ! f0 . poll ( change ) );
+    assert ( x . add ( "Prague", "Thakurova", "Dejvice", 12345 ) );
+    assert ( x . add ( "Prague", "Evropska", "Vokovice", 12345 ) );
+    assert ( ! x . add ( "Prague", "Evropska", "Vokovice", 12345 ) );
+    assert ( x . newOwner ( "Prague", "Thakurova", "CVUT" ) );
+    assert ( ! x . newOwner ( "Dejvice", 12345, "CVUT" ) );
+    assert ( x . del ( "Vokovice", 12345 ) );
+    assert ( x . nextSequence () == 4 );
+
+    assert ( f0 . poll ( change )
+             && change . m_Type == CLandRegister::EChangeType::Add
+             && change . m_Sequence == 0
+             && change . m_City == "Prague"
+             && change . m_Address == "Thakurova"
+             && change . m_Region == "Dejvice"
+             && change . m_ID == 12345
+             && change . m_Owner == "" );
+    assert ( f0 . poll ( change )
+             && change . m_Type == CLandRegister::EChangeType::Add
+             && change . m_Sequence == 1
+             && change . m_Address == "Evropska" );
+    assert ( f0 . poll ( change )
+             && change . m_Type == CLandRegister::EChangeType::NewOwner
+             && change . m_Sequence == 2
+             && change . m_Address == "Thakurova"
+             && change . m_Owner == "CVUT" );
+    assert ( f0 . poll ( change )
+             && change . m_Type == CLandRegister::EChangeType::Del
+             && change . m_Sequence == 3
+             && change . m_Region == "Vokovice"
+             && change . m_ID == 12345 );
+    assert ( ! f0 . poll ( change ) );
+    assert ( ! f0 . needsResync () );
+
+    CChangeFeed f1 = x . subscribe ( 2 );
+    assert ( x . add ( "Plzen", "Evropska", "Plzen mesto", 78901 ) );
+    assert ( x . add ( "Liberec", "Evropska", "Librec", 4552 ) );
+    assert ( x . del ( "Prague", "Thakurova" ) );
+    assert ( f1 . needsResync () );
+    assert ( ! f1 . poll ( change ) );
+    f1 . resync ();
+    assert ( ! f1 . needsResync () && f1 . sequence () == 7 );
+    assert ( ! f1 . poll ( change ) );
+
+    assert ( f0 . poll ( change ) && change . m_Sequence == 4 );
+    assert ( f0 . poll ( change ) && change . m_Sequence == 5 );
+    assert ( f0 . poll ( change )
+             && change . m_Type == CLandRegister::EChangeType::Del
+             && change . m_Sequence == 6
+             && change . m_Owner == "CVUT" );
+    assert ( ! f0 . poll ( change ) );
+
+    // Changes before the first subscription were never recorded
+    CLandRegister y;
+    assert ( y . add ( "Prague", "Thakurova", "Dejvice", 12345 ) );
+    CChangeFeed f2 = y . subscribe ( 0 );
+    assert ( f2 . needsResync () && ! f2 . poll ( change ) );
+    CChangeFeed f3 = y . subscribe ( y . nextSequence () );
+    assert ( y . newOwner ( "Dejvice", 12345, "CVUT" ) );
+    assert ( f3 . poll ( change )
+             && change . m_Type == CLandRegister::EChangeType::NewOwner
+             && change . m_Sequence == 1
+             && change . m_Owner == "CVUT" );
+
+    // Capacity 0 turns the feed off
+    CLandRegister z ( 0 );
+    CChangeFeed f4 = z . subscribe ( 0 );
+    assert ( ! f4 . needsResync () );
+    assert ( z . add ( "Prague", "Thakurova", "Dejvice", 12345 ) );
+    assert ( f4 . needsResync () && ! f4 . poll ( change ) );
+    assert ( z . memoryUsage () . m_ChangeLog == 0 );
+}
+
+static void test3 ()
+{
+    CLandRegister x;
+    std::string owner;
+
+    x . setOwnerCacheCapacity ( 2 );
+    assert ( x . add ( "Prague", "Thakurova", "Dejvice", 12345 ) );
+    assert ( x . add ( "Prague", "Evropska", "Vokovice", 12345 ) );
+    assert ( x . add ( "Prague", "Technicka", "Dejvice", 9873 ) );
+    assert ( x . newOwner ( "Prague", "Thakurova", "CVUT" ) );
+
+    assert ( x . getOwner ( "Prague", "Thakurova", owner ) && owner == "CVUT" );
+    assert ( x . getOwner ( "Prague", "Thakurova", owner ) && owner == "CVUT" );
+    assert ( x . ownerCacheHits () == 1 && x . ownerCacheMisses () == 1 );
+    assert ( ! x . getOwner ( "Prague", "THAKUROVA", owner ) );
+    assert ( ! x . getOwner ( "Prague", "THAKUROVA", owner ) );
+    assert ( x . ownerCacheHits () == 1 && x . ownerCacheMisses () == 3 );
+
+    assert ( x . getOwner ( "Dejvice", 12345, owner ) && owner == "CVUT" );
+    assert ( x . newOwner ( "Dejvice", 12345, "Anton Hrabis" ) );
+    assert ( x . getOwner ( "Prague", "Thakurova", owner ) && owner == "Anton Hrabis" );
+    assert ( x . getOwner ( "Dejvice", 12345, owner ) && owner == "Anton Hrabis" );
+    assert ( x . ownerCacheHits () == 1 && x . ownerCacheMisses () == 6 );
+    assert ( x . getOwner ( "Dejvice", 12345, owner ) && owner == "Anton Hrabis" );
+    assert ( x . ownerCacheHits () == 2 );
+
+    // Capacity 2, Thakurova is evicted by the two newer keys
+    assert ( x . getOwner ( "Prague", "Evropska", owner ) && owner == "" );
+    assert ( x . getOwner ( "Prague", "Technicka", owner ) && owner == "" );
+    assert ( x . getOwner ( "Prague", "Thakurova", owner ) && owner == "Anton Hrabis" );
+    assert ( x . ownerCacheHits () == 2 && x . ownerCacheMisses () == 9 );
+
+    assert ( x . del ( "Dejvice", 12345 ) );
+    assert ( ! x . getOwner ( "Prague", "Thakurova", owner ) );
+    assert ( ! x . getOwner ( "Dejvice", 12345, owner ) );
+    assert ( x . add ( "Prague", "Thakurova", "Dejvice", 12345 ) );
+    assert ( x . getOwner ( "Prague", "Thakurova", owner ) && owner == "" );
+    assert ( x . getOwner ( "Dejvice", 12345, owner ) && owner == "" );
+    // Keys longer than the small string buffer
+    assert ( x . add ( "Praha Hlavni mesto", "Jugoslavskych partyzanu", "Praha 6 Dejvice a Bubenec", 1 ) );
+    assert ( x . getOwner ( "Praha Hlavni mesto", "Jugoslavskych partyzanu", owner ) && owner == "" );
+    assert ( x . newOwner ( "Praha 6 Dejvice a Bubenec", 1, "Ceske vysoke uceni technicke" ) );
+    assert ( x . getOwner ( "Praha Hlavni mesto", "Jugoslavskych partyzanu", owner ) && owner == "Ceske vysoke uceni technicke" );
+    assert ( x . getOwner ( "Praha 6 Dejvice a Bubenec", 1, owner ) && owner == "Ceske vysoke uceni technicke" );
+    assert ( ! x . getOwner ( "Praha Hlavni mesto", "JUGOSLAVSKYCH PARTYZANU", owner ) );
+}
+
+static void test4 ()
+{
+    CLandRegister x;
+    CLandRegister y;
+    std::string owner;
+    size_t liveBytes, frozenBytes;
+
+    assert ( ! x . freezeReport ( liveBytes, frozenBytes ) );
+    for ( CLandRegister * r : { & x, & y } )
+    {
+        assert ( r -> add ( "Prague", "Thakurova", "Dejvice", 12345 ) );
+        assert ( r -> add ( "Prague", "Evropska", "Vokovice", 12345 ) );
+        assert ( r -> add ( "Prague", "Technicka", "Dejvice", 9873 ) );
+        assert ( r -> add ( "Plzen", "Evropska", "Plzen mesto", 78901 ) );
+        assert ( r -> add ( "Liberec", "Evropska", "Librec", 4552 ) );
+        assert ( r -> add ( "Tokyo", "Nagana", "Tokyo City", 12020203993 ) );
+        for ( int i = 0; i < 500; i ++ )
+        {
+            assert ( r -> add ( "Brno", "Bozetechova " + std::to_string ( i * 7 % 500 ), "Kralovo Pole", i * 3 ) );
+            assert ( r -> add ( "Brno", "Purkynova " + std::to_string ( i ), "Medlanky", 1000000 - i * i ) );
+        }
+        assert ( r -> newOwner ( "Prague", "Thakurova", "CVUT" ) );
+        assert ( r -> newOwner ( "Dejvice", 9873, "CVUT" ) );
+        assert ( r -> newOwner ( "Librec", 4552, "Cvut" ) );
+        assert ( r -> newOwner ( "Kralovo Pole", 300, "VUT" ) );
+        assert ( r -> del ( "Medlanky", 1000000 ) );
+    }
+
+    {
+        CIterator i = x . listByAddr ();
+        CIterator j = i;
+        assert ( ! x . freeze () && ! x . frozen () );
+    }
+    assert ( x . freeze () );
+    assert ( ! x . freeze () );
+    assert ( x . frozen () && ! y . frozen () );
+    assert ( x . freezeReport ( liveBytes, frozenBytes ) && frozenBytes < liveBytes );
+
+    assert ( ! x . add ( "Prague", "Kolejni", "Dejvice", 1 ) );
+    assert ( ! x . del ( "Prague", "Thakurova" ) );
+    assert ( ! x . del ( "Dejvice", 12345 ) );
+    assert ( ! x . newOwner ( "Prague", "Evropska", "CVUT" ) );
+    assert ( ! x . newOwner ( "Vokovice", 12345, "CVUT" ) );
+
+    assert ( x . getOwner ( "Prague", "Thakurova", owner ) && owner == "CVUT" );
+    assert ( ! x . getOwner ( "Prague", "THAKUROVA", owner ) );
+    assert ( ! x . getOwner ( "Praha", "Thakurova", owner ) );
+    assert ( x . getOwner ( "Tokyo City", 12020203993, owner ) && owner == "" );
+    assert ( x . getOwner ( "Kralovo Pole", 300, owner ) && owner == "VUT" );
+    assert ( ! x . getOwner ( "Kralovo Pole", 301, owner ) );
+    assert ( ! x . getOwner ( "Medlanky", 1000000, owner ) );
+    assert ( ! x . getOwner ( "Brno", "Purkynova 0", owner ) );
+    assert ( x . getOwner ( "Brno", "Purkynova 499", owner ) && owner == "" );
+    assert ( x . count ( "cvut" ) == 3 && x . count ( "" ) == 1001 && x . count ( "nobody" ) == 0 );
+
+    // CIterator::id () is unsigned, Tokyo's id does not fit and is skipped for the id lookup
+    CIterator i0 = x . listByAddr ();
+    CIterator i1 = y . listByAddr ();
+    // A frozen listByAddr walks a row range and allocates nothing per row
+    assert ( x . memoryUsage () . m_Iterators == 0 );
+    for ( ; ! i1 . atEnd (); i0 . next (), i1 . next () )
+        assert ( ! i0 . atEnd ()
+                 && i0 . city () == i1 . city ()
+                 && i0 . addr () == i1 . addr ()
+                 && i0 . region () == i1 . region ()
+                 && i0 . id () == i1 . id ()
+                 && i0 . owner () == i1 . owner ()
+                 && ( i1 . region () == "Tokyo City" || x . getOwner ( i1 . region (), i1 . id (), owner ) )
+                 && x . getOwner ( i1 . city (), i1 . addr (), owner ) );
+    assert ( i0 . atEnd () );
+
+    CIterator i2 = x . listByOwner ( "cVuT" );
+    assert ( ! i2 . atEnd ()
+             && i2 . city () == "Prague"
+             && i2 . addr () == "Thakurova"
+             && i2 . region () == "Dejvice"
+             && i2 . id () == 12345
+             && i2 . owner () == "CVUT" );
+    i2 . next ();
+    assert ( ! i2 . atEnd ()
+             && i2 . city () == "Prague"
+             && i2 . addr () == "Technicka"
+             && i2 . owner () == "CVUT" );
+    i2 . next ();
+    assert ( ! i2 . atEnd ()
+             && i2 . city () == "Liberec"
+             && i2 . owner () == "Cvut" );
+    i2 . next ();
+    assert ( i2 . atEnd () );
+}
+
+static CAsyncLookup::CLookupTask asyncOwnerByAddr ( CAsyncLookup & front, std::string city, std::string addr,
+                                                    int & found, std::string & owner )
+{
+    bool result = co_await front . getOwner ( city, addr, owner );
+    if ( result )
+        found ++;
+}
+
+static CAsyncLookup::CLookupTask asyncOwnerTwice ( CAsyncLookup & front, std::string region, unsigned long long id,
+                                                   std::string city, std::string addr, int & found, std::string & owner )
+{
+    std::string first;
+    bool byRegion = co_await front . getOwner ( region, id, first );
+    bool byAddr = co_await front . getOwner ( city, addr, owner );
+    if ( byRegion && byAddr && first == owner )
+        found ++;
+}
+
+static void test5 ()
+{
+    CLandRegister x;
+    std::string owners[1000];
+    int found = 0;
+
+    assert ( x . add ( "Prague", "Thakurova", "Dejvice", 12345 ) );
+    assert ( x . add ( "Prague", "Evropska", "Vokovice", 12345 ) );
+    assert ( x . add ( "Prague", "Technicka", "Dejvice", 9873 ) );
+    for ( int i = 0; i < 500; i ++ )
+        assert ( x . add ( "Brno", "Kolejni " + std::to_string ( i ), "Kralovo Pole", i * 11 ) );
+    assert ( x . newOwner ( "Prague", "Thakurova", "CVUT" ) );
+    assert ( x . newOwner ( "Kralovo Pole", 2189, "VUT" ) );
+
+    CAsyncLookup front ( x, 8 );
+    asyncOwnerByAddr ( front, "Prague", "Thakurova", found, owners[0] );
+    asyncOwnerByAddr ( front, "Prague", "THAKUROVA", found, owners[1] );
+    asyncOwnerByAddr ( front, "Prague", "", found, owners[2] );
+    asyncOwnerTwice ( front, "Dejvice", 12345, "Prague", "Thakurova", found, owners[3] );
+    asyncOwnerTwice ( front, "Kralovo Pole", 2189, "Brno", "Kolejni 199", found, owners[4] );
+    asyncOwnerTwice ( front, "Kralovo Pole", 2190, "Brno", "Kolejni 199", found, owners[5] );
+    assert ( front . pending () == 5 && found == 0 );
+    assert ( front . run () == 8 );
+    assert ( front . pending () == 0 && found == 3 );
+    assert ( owners[0] == "CVUT" && owners[1] == "" && owners[3] == "CVUT" && owners[4] == "VUT" );
+
+    found = 0;
+    for ( int i = 999; i >= 0; i -- )
+        asyncOwnerByAddr ( front, "Brno", "Kolejni " + std::to_string ( i ), found, owners[i] );
+    assert ( front . run () == 1000 && found == 500 );
+    assert ( owners[199] == "VUT" && owners[200] == "" );
+
+    // Owner cache is consulted before batching and filled by the batch
+    x . setOwnerCacheCapacity ( 16 );
+    found = 0;
+    asyncOwnerByAddr ( front, "Prague", "Thakurova", found, owners[0] );
+    assert ( front . pending () == 1 && x . ownerCacheMisses () == 1 );
+    assert ( front . run () == 1 && found == 1 );
+    asyncOwnerByAddr ( front, "Prague", "Thakurova", found, owners[1] );
+    assert ( front . pending () == 0 && found == 2 && owners[1] == "CVUT" );
+    assert ( x . ownerCacheHits () == 1 && x . ownerCacheMisses () == 1 );
+    x . setOwnerCacheCapacity ( 0 );
+
+    // Destroying the front end releases coroutines still waiting on it
+    {
+        CAsyncLookup abandoned ( x );
+        asyncOwnerTwice ( abandoned, "Kralovo Pole", 2189, "Brno", "Kolejni 199", found, owners[0] );
+        asyncOwnerByAddr ( abandoned, "Prague", "Technicka", found, owners[1] );
+        assert ( abandoned . pending () == 2 );
+    }
+    assert ( found == 2 );
+
+    assert ( x . freeze () );
+    x . setOwnerCacheCapacity ( 8 );
+    size_t misses = x . ownerCacheMisses ();
+    found = 0;
+    asyncOwnerTwice ( front, "Kralovo Pole", 2189, "Brno", "Kolejni 199", found, owners[0] );
+    asyncOwnerByAddr ( front, "Prague", "Technicka", found, owners[1] );
+    assert ( front . run () == 3 && found == 2 && owners[0] == "VUT" );
+    assert ( x . ownerCacheMisses () == misses );
+}
+
+// Reported usage must not exceed what was really allocated and may miss only a little of it
+static bool withinTrackedBounds ( const CLandRegister::CMemoryUsage & usage, size_t baseline )
+{
+    size_t tracked = g_AllocatedBytes - baseline;
+    return usage . total () <= tracked && tracked - usage . total () <= tracked / 20 + 1024;
+}
+
+static void test6 ()
+{
+    const size_t parcels = 2000;
+    size_t baseline = g_AllocatedBytes;
+    {
+        CLandRegister x;
+        for ( size_t i = 0; i < parcels; i ++ )
+            assert ( x . add ( "Prague", "Technicka " + std::to_string ( i ), "Dejvice", i ) );
+
+        CLandRegister::CMemoryUsage usage = x . memoryUsage ();
+        assert ( withinTrackedBounds ( usage, baseline ) );
+        assert ( usage . m_Properties == parcels * ( 4 * sizeof ( std::string ) + 2 * sizeof ( unsigned long long ) ) );
+        assert ( usage . m_CityAddrIndex >= parcels * sizeof ( void * ) && usage . m_CityAddrIndex <= 2 * parcels * sizeof ( void * ) );
+        assert ( usage . m_RegionIdIndex >= parcels * sizeof ( void * ) && usage . m_RegionIdIndex <= 2 * parcels * sizeof ( void * ) );
+        assert ( usage . m_ChangeLog == 0 );
+        assert ( usage . m_OwnerIndex == 0 && usage . m_Iterators == 0 && usage . m_OwnerCache == 0 && usage . m_ColumnStore == 0 );
+        assert ( usage . total () <= parcels * 256 );
+
+        {
+            CIterator i0 = x . listByAddr ();
+            CIterator i1 = i0;
+            assert ( x . memoryUsage () . m_Iterators == 2 * parcels * sizeof ( void * ) );
+            assert ( withinTrackedBounds ( x . memoryUsage (), baseline ) );
+        }
+        assert ( x . memoryUsage () . m_Iterators == 0 );
+
+        for ( size_t i = 0; i < parcels; i += 2 )
+            assert ( x . del ( "Dejvice", i ) );
+        assert ( x . newOwner ( "Dejvice", 1, "Ceske vysoke uceni technicke v Praze" ) );
+        assert ( x . newOwner ( "Dejvice", 1, "CVUT" ) );
+        size_t beforeShrink = x . memoryUsage () . total ();
+        x . shrinkToFit ();
+        usage = x . memoryUsage ();
+        assert ( withinTrackedBounds ( usage, baseline ) );
+        assert ( usage . total () < beforeShrink );
+        assert ( usage . m_CityAddrIndex == parcels / 2 * sizeof ( void * ) );
+        assert ( usage . m_RegionIdIndex == parcels / 2 * sizeof ( void * ) );
+
+        x . setOwnerCacheCapacity ( 8 );
+        std::string owner;
+        assert ( x . getOwner ( "Dejvice", 1, owner ) && owner == "CVUT" );
+        assert ( x . memoryUsage () . m_OwnerCache > 0 );
+        assert ( withinTrackedBounds ( x . memoryUsage (), baseline ) );
+
+        assert ( x . freeze () );
+        usage = x . memoryUsage ();
+        assert ( usage . m_Properties == 0 && usage . m_Strings == 0 && usage . m_CityAddrIndex == 0 );
+        assert ( usage . m_ColumnStore > 0 && usage . m_OwnerCache == 0 );
+        assert ( withinTrackedBounds ( usage, baseline ) );
+    }
+    assert ( g_AllocatedBytes == baseline );
+
+    // An iterator may outlive its register
+    CLandRegister * r = new CLandRegister ();
+    assert ( r -> add ( "Prague", "Thakurova", "Dejvice", 12345 ) );
+    CIterator * i2 = new CIterator ( r -> listByAddr () );
+    delete r;
+    delete i2;
+    assert ( g_AllocatedBytes == baseline );
+}
+
 int main ( void )
 {
     test0 ();
     test1 ();
+    test2 ();
+    test3 ();
+    test4 ();
+    test5 ();
+    test6 ();
     return EXIT_SUCCESS;
 }
 #endif /* __PROGTEST__ */
\ No newline at end of file